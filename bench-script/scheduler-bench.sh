@@ -0,0 +1,55 @@
+#!/bin/sh
+# Run pub-many-sub without realtime/taps once per scheduler backend and
+# subscriber count, and collect the SchedulerBench lines as CSV.
+#
+# There are no tap bridges or external hosts in these runs.  The scenario
+# drives synthetic UDP traffic instead: the publisher sends to the broker
+# and the broker sends to every subscriber, each stream at MSG_RATE
+# messages/s of MSG_SIZE bytes.
+#
+# Columns: events = executed events, cancelled = cancelled events that
+# were still dequeued, removed = events taken out with Simulator::Remove,
+# peakRssKB = process peak RSS, runRssKB = peak RSS growth during
+# Simulator::Run ().
+#
+# Run from the ns-3 top-level directory (where ./waf lives):
+#   sh scratch/bench-script/scheduler-bench.sh [simTime] [numNodes...]
+#
+# Defaults: 60 simulated seconds, numNodes 1 10 50 100 250 500,
+# MSG_RATE=10, MSG_SIZE=512.  Any failed run stops the sweep with a
+# non-zero exit status and the tail of its output.
+
+SIM_TIME=${1:-60}
+[ $# -gt 0 ] && shift
+NUM_NODES=${*:-"1 10 50 100 250 500"}
+SCHEDULERS="map list heap calendar priority-queue"
+MSG_RATE=${MSG_RATE:-10}
+MSG_SIZE=${MSG_SIZE:-512}
+OUT=${OUT:-scheduler-bench.csv}
+
+./waf build || exit 1
+
+LOG=$(mktemp)
+trap 'rm -f $LOG' EXIT
+
+echo "backend,numNodes,events,cancelled,removed,inserted,wallSec,eventsPerSec,peakQueue,peakRssKB,runRssKB" > $OUT
+for n in $NUM_NODES; do
+  for s in $SCHEDULERS; do
+    echo "== scheduler=$s numNodes=$n"
+    if ! ./waf --run "pub-many-sub --realtime=false --scheduler=$s --numNodes=$n --simTime=$SIM_TIME --msgRate=$MSG_RATE --msgSize=$MSG_SIZE --topologyFile=" > $LOG 2>&1; then
+      echo "FAILED: scheduler=$s numNodes=$n, last output:" >&2
+      tail -n 20 $LOG >&2
+      exit 1
+    fi
+    if [ "$(grep -c '^SchedulerBench' $LOG)" -ne 1 ]; then
+      echo "FAILED: scheduler=$s numNodes=$n did not print one SchedulerBench line" >&2
+      tail -n 20 $LOG >&2
+      exit 1
+    fi
+    grep '^SchedulerBench' $LOG \
+      | sed -e 's/^SchedulerBench //' -e 's/[A-Za-z]*=//g' -e 's/ /,/g' \
+      | tee -a $OUT
+  done
+done
+
+echo "Results written to $OUT"
@@ -1,10 +1,10 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 
 #include <iostream>
-#include <iomanip>
 #include <sstream>
 #include <string>
 #include <fstream>
+#include <vector>
 
 #include "ns3/core-module.h"
 #include "ns3/network-module.h"
@@ -17,114 +17,13 @@
 #include "ns3/ipv4-global-routing-helper.h"
 #include "ns3/tap-bridge-module.h"
 
+#include "pubsub-topology.h"
+#include "pubsub-scheduler.h"
+
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE ("PubSubNetwork");
 
-/**************************************************
- *
- */
-std::string
-ChannelType(Ptr<Channel> channel) 
-{
-  if (channel->GetObject<PointToPointChannel>())
-    return "P2P"; 
-  if (channel->GetObject<CsmaChannel>())
-    return "CSMA"; 
-  if (channel->GetObject<YansWifiChannel>())
-    return "WiFi"; 
-  return "Unknown";
-}
-
-/**************************************************
- *
- */
-std::string
-DeviceIpv4Info(Ptr<NetDevice> device) 
-{
-  std::ostringstream os;
-  Ptr<Node> node = device->GetNode();
-  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
-
-  if (ipv4 != nullptr) 
-  {
-    int32_t ifno = ipv4->GetInterfaceForDevice(device);
-    int32_t num_addr = ipv4->GetNAddresses(ifno);
-    if (num_addr > 0) 
-    {
-      Ipv4InterfaceAddress addr = ipv4->GetAddress(ifno,0);
-      os << "#IP:" << num_addr
-         << " | 1st-IP:" << addr.GetLocal();
-    }
-    else 
-      os << "#IP:0";
-  }
-  else 
-    os << "(IP STACK NOT INSTALLED)";
-  return os.str();
-}
-
-/**************************************************
- *
- */
-void
-ListChannels() 
-{
-  std::cout << "Channel List" << std::endl
-            << "============"
-            << std::endl;
-  for (uint16_t i = 0; i < ChannelList::GetNChannels(); i++) 
-  {
-    Ptr<Channel> channel = ChannelList::GetChannel(i);
-    std::cout << "Channel " << i
-              << " (" << ChannelType(channel) << ")"
-              << " has " << channel->GetNDevices() 
-              << " device(s) attached" << std::endl;
-    for (uint16_t j = 0; j < channel->GetNDevices(); j++) 
-    {
-      Ptr<NetDevice> device = channel->GetDevice(j);
-      Ptr<Node> node = device->GetNode();
-      std::cout << "- node:" << node->GetId()
-                << " | device:" << device->GetIfIndex()
-                << " | " << DeviceIpv4Info(device)
-                << std::endl;
-    }
-  }
-}
-
-/**************************************************
- *
- */
-void
-ListNodes() 
-{
-  std::cout << "Node List" << std::endl
-            << "========="
-            << std::endl;
-  for (uint16_t i = 0; i < NodeList::GetNNodes(); i++) 
-  {
-    Ptr<Node> node = NodeList::GetNode(i);
-    int32_t id = node->GetId();
-    std::cout << "Node " << id << std::endl;
-    for (uint16_t j = 0; j < node->GetNDevices(); j++) 
-    {
-      Ptr<NetDevice> device = node->GetDevice(j);
-      Ptr<Channel> channel = device->GetChannel();
-      std::ostringstream os;
-      if (channel)
-        os << channel->GetId() << " (" << ChannelType(channel) << ")";
-      else
-        os << "none";
-
-      std::cout 
-        << "- device:" << device->GetIfIndex()
-        << " | channel:" << std::setw(10) << std::left << os.str()
-        << " | " << DeviceIpv4Info(device)
-        << std::endl;
-    }
-  }
-}
-
 /**************************************************
  *
  */
@@ -132,12 +31,38 @@ int main (int argc, char *argv[])
 {
   int numNodes = 1;
   int staticDownlinkRate = 0;
+  std::string topologyFile = "pub-many-sub-topology.json";
+  bool realtime = true;
+  std::string scheduler;
+  double simTime = 6000.;
+  double msgRate = 10.;
+  uint32_t msgSize = 512;
   CommandLine cmd;
   cmd.AddValue ("numNodes", "Number of nodes/devices", numNodes);
   cmd.AddValue ("staticDownlinkRate", "Downlink data rate in kBps", staticDownlinkRate);
+  cmd.AddValue ("topologyFile", "Topology snapshot file (.json or .graphml, - for stdout, empty to skip)", topologyFile);
+  cmd.AddValue ("realtime", "Run in real time with tap bridges (false: discrete-event run with synthetic pub/sub traffic, no taps)", realtime);
+  cmd.AddValue ("scheduler", "Event scheduler, needs --realtime=false: map (default), list, heap, calendar, priority-queue", scheduler);
+  cmd.AddValue ("simTime", "Simulated time in seconds", simTime);
+  cmd.AddValue ("msgRate", "Synthetic messages per second per stream when not realtime", msgRate);
+  cmd.AddValue ("msgSize", "Synthetic message size in bytes when not realtime", msgSize);
   cmd.Parse (argc,argv);
   std::cout << "NS3 NumNodes = " << numNodes << std::endl;
-  GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::RealtimeSimulatorImpl"));
+  // Second octets 2..255 are split between the per-subscriber /24s below
+  if (numNodes < 1 || numNodes > 127*256)
+    NS_FATAL_ERROR ("numNodes must be between 1 and " << 127*256);
+  if (realtime)
+  {
+    if (!scheduler.empty ())
+      NS_FATAL_ERROR ("--scheduler=" << scheduler << " needs --realtime=false");
+    GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::RealtimeSimulatorImpl"));
+  }
+  else
+  {
+    if (scheduler.empty ())
+      scheduler = "map";
+    InstallScheduler (scheduler);
+  }
   GlobalValue::Bind ("ChecksumEnabled", BooleanValue (true));
   
   std::string TapBaseName = "sub";
@@ -239,62 +164,111 @@ int main (int argc, char *argv[])
 
   InternetStackHelper internet;
   internet.Install(NodeContainer(broker_gw1,broker_gw2,publisher_gw,subscriberGatewayNodes));
+  // Without taps the end hosts live inside ns-3 and need their own stacks
+  if (!realtime)
+    internet.Install(NodeContainer(NodeContainer(publisher,broker),subscriberNodes));
 
   Ipv4AddressHelper ipv4;
   ipv4.SetBase("10.1.1.0", "255.255.255.0");
-  ipv4.Assign(NetDeviceContainer(devicesMid.Get(0), devicesMid.Get(1)));
+  NetDeviceContainer midIpDevices(devicesMid.Get(0), devicesMid.Get(1));
+  if (!realtime)
+    midIpDevices.Add(devicesMid.Get(2));
+  Ipv4InterfaceContainer midInterfaces = ipv4.Assign(midIpDevices);
   ipv4.SetBase("10.1.2.0", "255.255.255.0");
   ipv4.Assign(p2pRight);
   ipv4.SetBase("10.1.3.0", "255.255.255.0");
-  ipv4.Assign(NetDeviceContainer(devicesLeft.Get(1)));
+  NetDeviceContainer leftIpDevices(devicesLeft.Get(1));
+  if (!realtime)
+    leftIpDevices.Add(devicesLeft.Get(0));
+  ipv4.Assign(leftIpDevices);
   ipv4.SetBase("10.1.4.0", "255.255.255.0");
   ipv4.Assign(p2pLeft);
       
   std::string subscriberAddress;
   std::string p2pSubscriberAddress;
+  std::vector<Ipv4Address> subscriberAddresses;
   for (int i = 0; i < numNodes; i++) {
+      // Every block of 256 subscribers moves to the next pair of second
+      // octets: Wi-Fi cells use odd ones (10.3, 10.5, ...), gateway links
+      // even ones (10.2, 10.4, ...), so the first 256 keep their old nets.
+      std::string lo = std::to_string(i%256);
+      std::string wifiOctet = std::to_string(3+2*(i/256));
+      std::string p2pOctet = std::to_string(2+2*(i/256));
+
       // Set ip Subscriber-Gateways Network
-      subscriberAddress = "10.3."+std::to_string(i)+".0";
+      subscriberAddress = "10."+wifiOctet+"."+lo+".0";
       auto subscriberCharAddress = Ipv4Address(subscriberAddress.c_str());
       ipv4.SetBase(subscriberCharAddress, "255.255.255.0");
       ipv4.Assign(subscriberNetDeviceContainer[i].Get(1));
+      if (!realtime)
+        subscriberAddresses.push_back(ipv4.Assign(subscriberNetDeviceContainer[i].Get(0)).GetAddress(0));
 
       // Set ip Subscriber Gateways-Master Network
 
-      p2pSubscriberAddress = "10.2."+std::to_string(i)+".0";
+      p2pSubscriberAddress = "10."+p2pOctet+"."+lo+".0";
       auto p2pSubscriberCharAddress = Ipv4Address(p2pSubscriberAddress.c_str());
       ipv4.SetBase(p2pSubscriberCharAddress, "255.255.255.0");
       ipv4.Assign(p2pSubscriberGatewayDevices[i]);
   }
 
 
-  TapBridgeHelper tapBridge;
-  tapBridge.SetAttribute ("Mode", StringValue("UseBridge"));
-  tapBridge.SetAttribute ("DeviceName",StringValue("tap-pub" ));
-  tapBridge.Install (publisher, devicesLeft.Get (0));
-  tapBridge.SetAttribute ("DeviceName",StringValue("tap-mid" ));
-  tapBridge.Install (broker, devicesMid.Get (2));
-
-  for (int i = 0; i < numNodes; i++)
+  // TapBridge refuses to start outside the realtime simulator
+  if (realtime)
   {
-      std::stringstream tapName;
-      tapName << "tap-" << TapBaseName << (i+1) ;
-      NS_LOG_UNCOND ("Tap bridge = " + tapName.str ());
+    TapBridgeHelper tapBridge;
+    tapBridge.SetAttribute ("Mode", StringValue("UseBridge"));
+    tapBridge.SetAttribute ("DeviceName",StringValue("tap-pub" ));
+    tapBridge.Install (publisher, devicesLeft.Get (0));
+    tapBridge.SetAttribute ("DeviceName",StringValue("tap-mid" ));
+    tapBridge.Install (broker, devicesMid.Get (2));
+
+    for (int i = 0; i < numNodes; i++)
+    {
+        std::stringstream tapName;
+        tapName << "tap-" << TapBaseName << (i+1) ;
+        NS_LOG_UNCOND ("Tap bridge = " + tapName.str ());
 
-      tapBridge.SetAttribute ("DeviceName", StringValue (tapName.str ()));
-      tapBridge.Install (subscriberNodes.Get (i), subscriberNetDeviceContainer[i].Get (0));
+        tapBridge.SetAttribute ("DeviceName", StringValue (tapName.str ()));
+        tapBridge.Install (subscriberNodes.Get (i), subscriberNetDeviceContainer[i].Get (0));
 
+    }
+  }
+  else
+  {
+    ////////////////////////////
+    // Synthetic pub/sub traffic
+    ////////////////////////////
+    // Publisher streams to the broker, the broker streams the same rate to
+    // every subscriber, so each Wi-Fi cell carries data-path timers.
+    uint16_t port = 9;
+    OnOffHelper onOff ("ns3::UdpSocketFactory", Address ());
+    onOff.SetConstantRate (DataRate (static_cast<uint64_t> (msgRate * msgSize * 8)), msgSize);
+    PacketSinkHelper sink ("ns3::UdpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), port));
+
+    ApplicationContainer apps = sink.Install (NodeContainer (NodeContainer (broker), subscriberNodes));
+    onOff.SetAttribute ("Remote", AddressValue (InetSocketAddress (midInterfaces.GetAddress (2), port)));
+    apps.Add (onOff.Install (publisher));
+    for (int i = 0; i < numNodes; i++)
+    {
+      onOff.SetAttribute ("Remote", AddressValue (InetSocketAddress (subscriberAddresses[i], port)));
+      apps.Add (onOff.Install (broker));
+    }
+    apps.Start (Seconds (1.));
+    apps.Stop (Seconds (simTime));
   }
 
 
   Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
   std::cout << "*****check point *****" << std::endl;
-  ListChannels();
-  std::cout << std::endl;
-  ListNodes();
-  Simulator::Stop (Seconds (6000.));
+  if (!topologyFile.empty ())
+    WriteTopology (topologyFile);
+  Simulator::Stop (Seconds (simTime));
+  SchedulerRunSample runStart;
+  if (!realtime)
+    runStart = BeginSchedulerRun ();
   Simulator::Run ();
-  
+  if (!realtime)
+    PrintSchedulerStats (scheduler, numNodes, runStart);
 
   Simulator::Destroy ();
 }
\ No newline at end of file
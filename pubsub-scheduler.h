@@ -0,0 +1,231 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef PUBSUB_SCHEDULER_H
+#define PUBSUB_SCHEDULER_H
+
+// Event scheduler selection and instrumentation for the pub/sub scenarios.
+//
+// InstallScheduler() puts a CountingScheduler in front of one of the stock
+// ns-3 backends (map, list, heap, calendar, priority-queue).  The wrapper
+// forwards every call and counts executed events, cancelled events (still
+// dequeued, since EventId::Cancel() only flags them) and the peak queue
+// length.  PrintSchedulerStats() reports these together with wall clock
+// time and RSS growth since BeginSchedulerRun() once Simulator::Run()
+// returns.
+//
+// Only meant for the non-realtime simulator: under RealtimeSimulatorImpl the
+// run length is pinned to wall clock time and the numbers are meaningless.
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include <sys/resource.h>
+
+#include "ns3/core-module.h"
+
+/**************************************************
+ *
+ */
+inline std::string
+SchedulerTypeName (const std::string &backend)
+{
+  if (backend == "map")
+    return "ns3::MapScheduler";
+  if (backend == "list")
+    return "ns3::ListScheduler";
+  if (backend == "heap")
+    return "ns3::HeapScheduler";
+  if (backend == "calendar")
+    return "ns3::CalendarScheduler";
+  if (backend == "priority-queue")
+    return "ns3::PriorityQueueScheduler";
+  return "";
+}
+
+/**************************************************
+ *
+ */
+struct SchedulerStats
+{
+  uint64_t executed;
+  uint64_t cancelled;
+  uint64_t removed;
+  uint64_t inserted;
+  uint64_t size;
+  uint64_t peak;
+};
+
+/**************************************************
+ *
+ */
+class CountingScheduler : public ns3::Scheduler
+{
+public:
+  static ns3::TypeId
+  GetTypeId (void)
+  {
+    static ns3::TypeId tid = ns3::TypeId ("ns3::PubSubCountingScheduler")
+      .SetParent<ns3::Scheduler> ()
+      .AddConstructor<CountingScheduler> ()
+      .AddAttribute ("Backend",
+                     "TypeId name of the scheduler every call is forwarded to.",
+                     ns3::StringValue ("ns3::MapScheduler"),
+                     ns3::MakeStringAccessor (&CountingScheduler::SetBackend,
+                                              &CountingScheduler::GetBackend),
+                     ns3::MakeStringChecker ())
+    ;
+    return tid;
+  }
+
+  // The simulator owns the scheduler instance, so the counters live in a
+  // process-wide slot the scenario can read once the run is over.
+  static SchedulerStats &
+  GetStats (void)
+  {
+    static SchedulerStats stats = {0, 0, 0, 0, 0, 0};
+    return stats;
+  }
+
+  virtual void
+  Insert (const Event &ev)
+  {
+    m_backend->Insert (ev);
+    SchedulerStats &s = GetStats ();
+    s.inserted++;
+    if (++s.size > s.peak)
+      s.peak = s.size;
+  }
+
+  virtual bool
+  IsEmpty (void) const
+  {
+    return m_backend->IsEmpty ();
+  }
+
+  virtual Event
+  PeekNext (void) const
+  {
+    return m_backend->PeekNext ();
+  }
+
+  virtual Event
+  RemoveNext (void)
+  {
+    Event ev = m_backend->RemoveNext ();
+    SchedulerStats &s = GetStats ();
+    if (ev.impl->IsCancelled ())
+      s.cancelled++;
+    else
+      s.executed++;
+    s.size--;
+    return ev;
+  }
+
+  virtual void
+  Remove (const Event &ev)
+  {
+    SchedulerStats &s = GetStats ();
+    s.removed++;
+    s.size--;
+    m_backend->Remove (ev);
+  }
+
+private:
+  void
+  SetBackend (std::string typeName)
+  {
+    ns3::ObjectFactory factory;
+    factory.SetTypeId (typeName);
+    m_backend = factory.Create<ns3::Scheduler> ();
+    m_backendName = typeName;
+  }
+
+  std::string
+  GetBackend (void) const
+  {
+    return m_backendName;
+  }
+
+  ns3::Ptr<ns3::Scheduler> m_backend;
+  std::string m_backendName;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (CountingScheduler);
+
+/**************************************************
+ *
+ */
+inline void
+InstallScheduler (const std::string &backend)
+{
+  std::string typeName = SchedulerTypeName (backend);
+  if (typeName.empty ())
+    NS_FATAL_ERROR ("Unknown scheduler \"" << backend
+                    << "\" (map, list, heap, calendar, priority-queue)");
+
+  ns3::ObjectFactory factory;
+  factory.SetTypeId ("ns3::PubSubCountingScheduler");
+  factory.Set ("Backend", ns3::StringValue (typeName));
+  ns3::Simulator::SetScheduler (factory);
+}
+
+/**************************************************
+ *
+ */
+struct SchedulerRunSample
+{
+  std::chrono::steady_clock::time_point start;
+  long peakRssKB;
+};
+
+inline long
+PeakRssKB (void)
+{
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+// Call right before Simulator::Run (); topology, Wi-Fi and IP objects are
+// already allocated, so RSS growth after this point is the event queue and
+// whatever the running protocols allocate.
+inline SchedulerRunSample
+BeginSchedulerRun (void)
+{
+  SchedulerRunSample sample;
+  sample.start = std::chrono::steady_clock::now ();
+  sample.peakRssKB = PeakRssKB ();
+  return sample;
+}
+
+/**************************************************
+ *
+ */
+inline void
+PrintSchedulerStats (const std::string &backend, int numNodes,
+                     const SchedulerRunSample &runStart)
+{
+  const SchedulerStats &s = CountingScheduler::GetStats ();
+  double seconds = std::chrono::duration<double> (std::chrono::steady_clock::now ()
+                                                  - runStart.start).count ();
+  long peakRssKB = PeakRssKB ();
+
+  // One key=value line so bench-script/scheduler-bench.sh can grep it.
+  std::cout << "SchedulerBench"
+            << " backend=" << backend
+            << " numNodes=" << numNodes
+            << " events=" << s.executed
+            << " cancelled=" << s.cancelled
+            << " removed=" << s.removed
+            << " inserted=" << s.inserted
+            << " wallSec=" << seconds
+            << " eventsPerSec=" << (seconds > 0 ? s.executed / seconds : 0)
+            << " peakQueue=" << s.peak
+            << " peakRssKB=" << peakRssKB
+            << " runRssKB=" << (peakRssKB - runStart.peakRssKB)
+            << std::endl;
+}
+
+#endif /* PUBSUB_SCHEDULER_H */
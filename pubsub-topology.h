@@ -0,0 +1,433 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef PUBSUB_TOPOLOGY_H
+#define PUBSUB_TOPOLOGY_H
+
+// Topology introspection shared by the pub/sub scenarios.
+//
+// WriteTopology() walks ChannelList and NodeList exactly once each and
+// writes a snapshot of nodes, devices, channels, IPv4 addresses and link
+// rates.  The output format is picked from the file name: "*.graphml"
+// gives GraphML (nodes and channels as vertices, devices as edges; devices
+// without a channel, e.g. TapBridge, become a "detached" node attribute),
+// any other name gives JSON.  The file name "-" writes JSON to stdout.
+//
+// Wi-Fi links have no fixed rate: WifiNetDevice and YansWifiChannel carry
+// no DataRate attribute and the rate is picked per frame by the remote
+// station manager.  Wi-Fi devices therefore report the manager type as
+// "rateControl" and leave "dataRate" empty, unless the manager pins a
+// single "DataMode" (e.g. ConstantRateWifiManager), which is reported
+// instead.
+//
+// Output goes through a single buffered stream; nothing is flushed until
+// the snapshot is complete.
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+
+/**************************************************
+ *
+ */
+struct TopologyAddress
+{
+  std::string local;
+  std::string mask;
+};
+
+struct TopologyDevice
+{
+  uint32_t ifIndex;
+  std::string type;
+  std::string mac;
+  int64_t channel;              // -1 when the device has no channel
+  std::string dataRate;
+  std::string rateControl;      // Wi-Fi remote station manager, else empty
+  std::vector<TopologyAddress> addresses;
+};
+
+struct TopologyNode
+{
+  uint32_t id;
+  std::string name;
+  bool hasIpv4;
+  std::vector<TopologyDevice> devices;
+};
+
+struct TopologyChannel
+{
+  uint32_t id;
+  std::string type;
+  std::string dataRate;
+  std::string delay;
+  uint32_t nDevices;
+};
+
+/**************************************************
+ *
+ */
+inline std::string
+TopologyTypeName (ns3::Ptr<ns3::Object> object)
+{
+  // TypeId lookup is a plain member read, unlike GetObject<> probes which
+  // search the aggregate once per candidate type.
+  std::string name = object->GetInstanceTypeId ().GetName ();
+  if (name.compare (0, 5, "ns3::") == 0)
+    name.erase (0, 5);
+  return name;
+}
+
+/**************************************************
+ *
+ */
+inline std::string
+TopologyChannelType (const std::string &typeName)
+{
+  if (typeName == "PointToPointChannel")
+    return "P2P";
+  if (typeName == "CsmaChannel")
+    return "CSMA";
+  if (typeName == "YansWifiChannel")
+    return "WiFi";
+  return typeName;
+}
+
+/**************************************************
+ *
+ */
+inline std::string
+TopologyAttribute (ns3::Ptr<ns3::Object> object, const std::string &name,
+                   ns3::AttributeValue &value)
+{
+  if (object && object->GetAttributeFailSafe (name, value))
+    return value.SerializeToString (ns3::Ptr<const ns3::AttributeChecker> ());
+  return "";
+}
+
+/**************************************************
+ *
+ */
+inline std::vector<TopologyChannel>
+CollectChannels ()
+{
+  std::vector<TopologyChannel> channels;
+  channels.reserve (ns3::ChannelList::GetNChannels ());
+  for (auto it = ns3::ChannelList::Begin (); it != ns3::ChannelList::End (); ++it)
+    {
+      ns3::Ptr<ns3::Channel> channel = *it;
+      ns3::DataRateValue rate;
+      ns3::TimeValue delay;
+
+      TopologyChannel c;
+      c.id = channel->GetId ();
+      c.type = TopologyChannelType (TopologyTypeName (channel));
+      c.dataRate = TopologyAttribute (channel, "DataRate", rate);
+      c.delay = TopologyAttribute (channel, "Delay", delay);
+      c.nDevices = channel->GetNDevices ();
+      channels.push_back (c);
+    }
+  return channels;
+}
+
+/**************************************************
+ *
+ */
+inline std::vector<TopologyNode>
+CollectNodes (const std::vector<TopologyChannel> &channels)
+{
+  std::vector<TopologyNode> nodes;
+  nodes.reserve (ns3::NodeList::GetNNodes ());
+  for (auto it = ns3::NodeList::Begin (); it != ns3::NodeList::End (); ++it)
+    {
+      ns3::Ptr<ns3::Node> node = *it;
+      ns3::Ptr<ns3::Ipv4> ipv4 = node->GetObject<ns3::Ipv4> ();
+
+      TopologyNode n;
+      n.id = node->GetId ();
+      n.name = ns3::Names::FindName (node);
+      n.hasIpv4 = (ipv4 != nullptr);
+      n.devices.reserve (node->GetNDevices ());
+
+      for (uint32_t j = 0; j < node->GetNDevices (); j++)
+        {
+          ns3::Ptr<ns3::NetDevice> device = node->GetDevice (j);
+          ns3::Ptr<ns3::Channel> channel = device->GetChannel ();
+
+          TopologyDevice d;
+          d.ifIndex = device->GetIfIndex ();
+          d.type = TopologyTypeName (device);
+          d.channel = channel ? static_cast<int64_t> (channel->GetId ()) : -1;
+
+          ns3::Address address = device->GetAddress ();
+          if (ns3::Mac48Address::IsMatchingType (address))
+            {
+              std::ostringstream os;
+              os << ns3::Mac48Address::ConvertFrom (address);
+              d.mac = os.str ();
+            }
+
+          // Rate is a device attribute for P2P and a channel attribute for
+          // CSMA; the channel one was already read in CollectChannels().
+          ns3::DataRateValue rate;
+          d.dataRate = TopologyAttribute (device, "DataRate", rate);
+          if (d.dataRate.empty () && d.channel >= 0
+              && static_cast<size_t> (d.channel) < channels.size ())
+            d.dataRate = channels[d.channel].dataRate;
+
+          // Wi-Fi: read the station manager through the generic attribute
+          // system so this header does not depend on the wifi module.
+          ns3::PointerValue manager;
+          if (device->GetAttributeFailSafe ("RemoteStationManager", manager)
+              && manager.GetObject ())
+            {
+              ns3::Ptr<ns3::Object> m = manager.GetObject ();
+              ns3::StringValue mode;
+              d.rateControl = TopologyTypeName (m);
+              if (d.dataRate.empty ())
+                d.dataRate = TopologyAttribute (m, "DataMode", mode);
+            }
+
+          if (ipv4 != nullptr)
+            {
+              int32_t ifno = ipv4->GetInterfaceForDevice (device);
+              if (ifno >= 0)
+                {
+                  uint32_t numAddr = ipv4->GetNAddresses (ifno);
+                  d.addresses.reserve (numAddr);
+                  for (uint32_t k = 0; k < numAddr; k++)
+                    {
+                      ns3::Ipv4InterfaceAddress addr = ipv4->GetAddress (ifno, k);
+                      std::ostringstream local, mask;
+                      local << addr.GetLocal ();
+                      mask << addr.GetMask ();
+                      d.addresses.push_back ({local.str (), mask.str ()});
+                    }
+                }
+            }
+          n.devices.push_back (d);
+        }
+      nodes.push_back (n);
+    }
+  return nodes;
+}
+
+/**************************************************
+ *
+ */
+inline std::string
+TopologyJsonEscape (const std::string &s)
+{
+  std::string out;
+  out.reserve (s.size ());
+  for (char c : s)
+    {
+      if (c == '"' || c == '\\')
+        {
+          out += '\\';
+          out += c;
+        }
+      else if (static_cast<unsigned char> (c) < 0x20)
+        {
+          char buf[8];
+          std::snprintf (buf, sizeof (buf), "\\u%04x", static_cast<unsigned char> (c));
+          out += buf;
+        }
+      else
+        out += c;
+    }
+  return out;
+}
+
+inline std::string
+TopologyXmlEscape (const std::string &s)
+{
+  std::string out;
+  out.reserve (s.size ());
+  for (char c : s)
+    {
+      switch (c)
+        {
+        case '"': out += "&quot;"; break;
+        case '&': out += "&amp;";  break;
+        case '<': out += "&lt;";   break;
+        case '>': out += "&gt;";   break;
+        case '\t': case '\n': case '\r': out += c; break;
+        default:
+          // Other control bytes are not allowed anywhere in XML 1.0
+          out += (static_cast<unsigned char> (c) < 0x20) ? '?' : c;
+        }
+    }
+  return out;
+}
+
+/**************************************************
+ *
+ */
+inline void
+WriteTopologyJson (std::ostream &os,
+                   const std::vector<TopologyNode> &nodes,
+                   const std::vector<TopologyChannel> &channels)
+{
+  os << "{\n  \"channels\": [";
+  for (size_t i = 0; i < channels.size (); i++)
+    {
+      const TopologyChannel &c = channels[i];
+      os << (i ? ",\n" : "\n")
+         << "    {\"id\": " << c.id
+         << ", \"type\": \"" << TopologyJsonEscape (c.type) << "\""
+         << ", \"dataRate\": \"" << c.dataRate << "\""
+         << ", \"delay\": \"" << c.delay << "\""
+         << ", \"nDevices\": " << c.nDevices << "}";
+    }
+  os << "\n  ],\n  \"nodes\": [";
+  for (size_t i = 0; i < nodes.size (); i++)
+    {
+      const TopologyNode &n = nodes[i];
+      os << (i ? ",\n" : "\n")
+         << "    {\"id\": " << n.id
+         << ", \"name\": \"" << TopologyJsonEscape (n.name) << "\""
+         << ", \"ipv4\": " << (n.hasIpv4 ? "true" : "false")
+         << ", \"devices\": [";
+      for (size_t j = 0; j < n.devices.size (); j++)
+        {
+          const TopologyDevice &d = n.devices[j];
+          os << (j ? ",\n" : "\n")
+             << "      {\"ifIndex\": " << d.ifIndex
+             << ", \"type\": \"" << TopologyJsonEscape (d.type) << "\""
+             << ", \"mac\": \"" << d.mac << "\""
+             << ", \"channel\": ";
+          if (d.channel >= 0)
+            os << d.channel;
+          else
+            os << "null";
+          os << ", \"dataRate\": \"" << TopologyJsonEscape (d.dataRate) << "\""
+             << ", \"rateControl\": \"" << TopologyJsonEscape (d.rateControl) << "\""
+             << ", \"addresses\": [";
+          for (size_t k = 0; k < d.addresses.size (); k++)
+            os << (k ? ", " : "")
+               << "{\"local\": \"" << d.addresses[k].local
+               << "\", \"mask\": \"" << d.addresses[k].mask << "\"}";
+          os << "]}";
+        }
+      os << (n.devices.empty () ? "]}" : "\n    ]}");
+    }
+  os << "\n  ]\n}\n";
+}
+
+/**************************************************
+ *
+ */
+inline void
+WriteTopologyGraphml (std::ostream &os,
+                      const std::vector<TopologyNode> &nodes,
+                      const std::vector<TopologyChannel> &channels)
+{
+  os << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+     << "<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\">\n"
+     << "  <key id=\"kind\" for=\"node\" attr.name=\"kind\" attr.type=\"string\"/>\n"
+     << "  <key id=\"name\" for=\"node\" attr.name=\"name\" attr.type=\"string\"/>\n"
+     << "  <key id=\"type\" for=\"all\" attr.name=\"type\" attr.type=\"string\"/>\n"
+     << "  <key id=\"rate\" for=\"all\" attr.name=\"dataRate\" attr.type=\"string\"/>\n"
+     << "  <key id=\"delay\" for=\"node\" attr.name=\"delay\" attr.type=\"string\"/>\n"
+     << "  <key id=\"detached\" for=\"node\" attr.name=\"detached\" attr.type=\"string\"/>\n"
+     << "  <key id=\"if\" for=\"edge\" attr.name=\"ifIndex\" attr.type=\"int\"/>\n"
+     << "  <key id=\"rc\" for=\"edge\" attr.name=\"rateControl\" attr.type=\"string\"/>\n"
+     << "  <key id=\"mac\" for=\"edge\" attr.name=\"mac\" attr.type=\"string\"/>\n"
+     << "  <key id=\"ip\" for=\"edge\" attr.name=\"ipv4\" attr.type=\"string\"/>\n"
+     << "  <graph id=\"topology\" edgedefault=\"undirected\">\n";
+
+  for (const TopologyChannel &c : channels)
+    os << "    <node id=\"c" << c.id << "\">"
+       << "<data key=\"kind\">channel</data>"
+       << "<data key=\"type\">" << TopologyXmlEscape (c.type) << "</data>"
+       << "<data key=\"rate\">" << c.dataRate << "</data>"
+       << "<data key=\"delay\">" << c.delay << "</data></node>\n";
+
+  // Devices without a channel cannot be edges; list them on their node as
+  // space separated "ifIndex:type" pairs.
+  for (const TopologyNode &n : nodes)
+    {
+      os << "    <node id=\"n" << n.id << "\">"
+         << "<data key=\"kind\">node</data>"
+         << "<data key=\"name\">" << TopologyXmlEscape (n.name) << "</data>";
+      bool first = true;
+      for (const TopologyDevice &d : n.devices)
+        {
+          if (d.channel >= 0)
+            continue;
+          os << (first ? "<data key=\"detached\">" : " ")
+             << d.ifIndex << ":" << TopologyXmlEscape (d.type);
+          first = false;
+        }
+      if (!first)
+        os << "</data>";
+      os << "</node>\n";
+    }
+
+  // Each attached device is an edge between its node and its channel;
+  // IPv4 addresses are joined as "addr/mask" separated by spaces.
+  for (const TopologyNode &n : nodes)
+    for (const TopologyDevice &d : n.devices)
+      {
+        if (d.channel < 0)
+          continue;
+        os << "    <edge source=\"n" << n.id << "\" target=\"c" << d.channel << "\">"
+           << "<data key=\"if\">" << d.ifIndex << "</data>"
+           << "<data key=\"type\">" << TopologyXmlEscape (d.type) << "</data>"
+           << "<data key=\"mac\">" << d.mac << "</data>"
+           << "<data key=\"rate\">" << TopologyXmlEscape (d.dataRate) << "</data>"
+           << "<data key=\"rc\">" << TopologyXmlEscape (d.rateControl) << "</data>"
+           << "<data key=\"ip\">";
+        for (size_t k = 0; k < d.addresses.size (); k++)
+          os << (k ? " " : "") << d.addresses[k].local << "/" << d.addresses[k].mask;
+        os << "</data></edge>\n";
+      }
+
+  os << "  </graph>\n</graphml>\n";
+}
+
+/**************************************************
+ *
+ */
+inline bool
+WriteTopology (const std::string &fileName)
+{
+  std::vector<TopologyChannel> channels = CollectChannels ();
+  std::vector<TopologyNode> nodes = CollectNodes (channels);
+
+  if (fileName == "-")
+    {
+      WriteTopologyJson (std::cout, nodes, channels);
+      std::cout.flush ();
+      return true;
+    }
+
+  std::ofstream out (fileName.c_str ());
+  if (!out)
+    {
+      std::cerr << "Cannot open topology file " << fileName << "\n";
+      return false;
+    }
+
+  const std::string ext = ".graphml";
+  bool graphml = fileName.size () >= ext.size ()
+    && fileName.compare (fileName.size () - ext.size (), ext.size (), ext) == 0;
+  if (graphml)
+    WriteTopologyGraphml (out, nodes, channels);
+  else
+    WriteTopologyJson (out, nodes, channels);
+
+  std::cout << "Topology: " << nodes.size () << " nodes, "
+            << channels.size () << " channels -> " << fileName << std::endl;
+  return true;
+}
+
+#endif /* PUBSUB_TOPOLOGY_H */
@@ -59,7 +59,6 @@
 #include <iostream>
 #include <fstream>
 
-#include <iomanip>
 #include <sstream>
 #include <string>
 
@@ -74,114 +73,12 @@
 #include "ns3/ipv4-global-routing-helper.h"
 #include "ns3/tap-bridge-module.h"
 
+#include "pubsub-topology.h"
+
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE ("PubSubNetwork");
 
-/**************************************************
- *
- */
-std::string
-ChannelType(Ptr<Channel> channel) 
-{
-  if (channel->GetObject<PointToPointChannel>())
-    return "P2P"; 
-  if (channel->GetObject<CsmaChannel>())
-    return "CSMA"; 
-  if (channel->GetObject<YansWifiChannel>())
-    return "WiFi"; 
-  return "Unknown";
-}
-
-/**************************************************
- *
- */
-std::string
-DeviceIpv4Info(Ptr<NetDevice> device) 
-{
-  std::ostringstream os;
-  Ptr<Node> node = device->GetNode();
-  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
-
-  if (ipv4 != nullptr) 
-  {
-    int32_t ifno = ipv4->GetInterfaceForDevice(device);
-    int32_t num_addr = ipv4->GetNAddresses(ifno);
-    if (num_addr > 0) 
-    {
-      Ipv4InterfaceAddress addr = ipv4->GetAddress(ifno,0);
-      os << "#IP:" << num_addr
-         << " | 1st-IP:" << addr.GetLocal();
-    }
-    else 
-      os << "#IP:0";
-  }
-  else 
-    os << "(IP STACK NOT INSTALLED)";
-  return os.str();
-}
-
-/**************************************************
- *
- */
-void
-ListChannels() 
-{
-  std::cout << "Channel List" << std::endl
-            << "============"
-            << std::endl;
-  for (uint16_t i = 0; i < ChannelList::GetNChannels(); i++) 
-  {
-    Ptr<Channel> channel = ChannelList::GetChannel(i);
-    std::cout << "Channel " << i
-              << " (" << ChannelType(channel) << ")"
-              << " has " << channel->GetNDevices() 
-              << " device(s) attached" << std::endl;
-    for (uint16_t j = 0; j < channel->GetNDevices(); j++) 
-    {
-      Ptr<NetDevice> device = channel->GetDevice(j);
-      Ptr<Node> node = device->GetNode();
-      std::cout << "- node:" << node->GetId()
-                << " | device:" << device->GetIfIndex()
-                << " | " << DeviceIpv4Info(device)
-                << std::endl;
-    }
-  }
-}
-
-/**************************************************
- *
- */
-void
-ListNodes() 
-{
-  std::cout << "Node List" << std::endl
-            << "========="
-            << std::endl;
-  for (uint16_t i = 0; i < NodeList::GetNNodes(); i++) 
-  {
-    Ptr<Node> node = NodeList::GetNode(i);
-    int32_t id = node->GetId();
-    std::cout << "Node " << id << std::endl;
-    for (uint16_t j = 0; j < node->GetNDevices(); j++) 
-    {
-      Ptr<NetDevice> device = node->GetDevice(j);
-      Ptr<Channel> channel = device->GetChannel();
-      std::ostringstream os;
-      if (channel)
-        os << channel->GetId() << " (" << ChannelType(channel) << ")";
-      else
-        os << "none";
-
-      std::cout 
-        << "- device:" << device->GetIfIndex()
-        << " | channel:" << std::setw(10) << std::left << os.str()
-        << " | " << DeviceIpv4Info(device)
-        << std::endl;
-    }
-  }
-}
-
 int 
 main (int argc, char *argv[])
 {
@@ -191,10 +88,12 @@ main (int argc, char *argv[])
   std::string tapPubName = "tap-pub";
   std::string tapSubName = "tap-sub";
   std::string tapMidName = "tap-mid";
+  std::string topologyFile = "tap-wifi-csma-topology.json";
 
   CommandLine cmd;
   cmd.AddValue ("mode", "Mode setting of TapBridge", mode);
   cmd.AddValue ("tapName", "Name of the OS tap device", tapName);
+  cmd.AddValue ("topologyFile", "Topology snapshot file (.json or .graphml, - for stdout, empty to skip)", topologyFile);
   cmd.Parse (argc, argv);
 
   GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::RealtimeSimulatorImpl"));
@@ -366,9 +265,8 @@ main (int argc, char *argv[])
 
   Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
   std::cout << "*****check point *****" << std::endl;
-  ListChannels();
-  std::cout << std::endl;
-  // ListNodes();
+  if (!topologyFile.empty ())
+    WriteTopology (topologyFile);
 
   NS_LOG_INFO ("Run Simulation.");
   Simulator::Stop (Seconds (6000.));